@@ -0,0 +1,96 @@
+#include <cassert>
+#include <cstring>
+#include <string>
+#include "cdict"
+#include "cdictglobal"
+
+namespace {
+    const int RECORDS_COUNT = 1000;
+
+    std::string key(int i) {
+        return "key" + std::to_string(i);
+    }
+
+    std::string value(int i) {
+        return "value" + std::to_string(i % 7);
+    }
+
+    [[maybe_unused]] bool has_value(unsigned long id, const std::string& k, const std::string& v) {
+        const char* found = ::jnp1::dict_find(id, k.c_str());
+        return found != NULL && v == found;
+    }
+}
+
+int main() {
+    // Lookups in frozen dictionary
+    const unsigned long id = ::jnp1::dict_new();
+    for (int i = 0; i < RECORDS_COUNT; ++i) {
+        ::jnp1::dict_insert(id, key(i).c_str(), value(i).c_str());
+    }
+    ::jnp1::dict_freeze(id);
+    assert(::jnp1::dict_size(id) == RECORDS_COUNT);
+    for (int i = 0; i < RECORDS_COUNT; ++i) {
+        assert(has_value(id, key(i), value(i)));
+    }
+    assert(::jnp1::dict_find(id, "missing") == NULL);
+    assert(::jnp1::dict_find(id, "") == NULL);
+
+    // Calls with NULL arguments do not thaw the dictionary
+    [[maybe_unused]] const char* frozen_value = ::jnp1::dict_find(id, key(3).c_str());
+    ::jnp1::dict_remove(id, NULL);
+    ::jnp1::dict_insert(id, NULL, "v");
+    ::jnp1::dict_upsert(id, key(3).c_str(), NULL);
+    assert(frozen_value != NULL && value(3) == frozen_value);
+
+    // Copy shares the image and both can be thawed separately
+    const unsigned long copy_id = ::jnp1::dict_new();
+    ::jnp1::dict_insert(copy_id, "old", "a");
+    ::jnp1::dict_copy(id, copy_id);
+    assert(::jnp1::dict_size(copy_id) == RECORDS_COUNT);
+    assert(::jnp1::dict_find(copy_id, "old") == NULL);
+    assert(has_value(copy_id, key(5), value(5)));
+
+    // Modification thaws the dictionary
+    ::jnp1::dict_insert(copy_id, "new", "b");
+    assert(::jnp1::dict_size(copy_id) == RECORDS_COUNT + 1);
+    assert(has_value(copy_id, "new", "b"));
+    assert(::jnp1::dict_size(id) == RECORDS_COUNT);
+    assert(::jnp1::dict_find(id, "new") == NULL);
+
+    ::jnp1::dict_remove(id, key(0).c_str());
+    assert(::jnp1::dict_size(id) == RECORDS_COUNT - 1);
+    assert(::jnp1::dict_find(id, key(0).c_str()) == NULL);
+    assert(has_value(id, key(1), value(1)));
+    assert(has_value(copy_id, key(0), value(0)));
+
+    // Frozen again and cleared
+    ::jnp1::dict_freeze(id);
+    assert(has_value(id, key(1), value(1)));
+    ::jnp1::dict_clear(id);
+    assert(::jnp1::dict_size(id) == 0);
+    assert(::jnp1::dict_find(id, key(1).c_str()) == NULL);
+
+    // Frozen empty dictionary
+    const unsigned long empty_id = ::jnp1::dict_new();
+    ::jnp1::dict_freeze(empty_id);
+    assert(::jnp1::dict_size(empty_id) == 0);
+    assert(::jnp1::dict_find(empty_id, "missing") == NULL);
+    ::jnp1::dict_insert(empty_id, "k", "v");
+    assert(has_value(empty_id, "k", "v"));
+
+    // Frozen global dictionary
+    ::jnp1::dict_insert(::jnp1::dict_global(), "g0", "d");
+    ::jnp1::dict_freeze(::jnp1::dict_global());
+    assert(::jnp1::dict_size(::jnp1::dict_global()) == 1);
+    assert(has_value(id, "g0", "d"));
+    assert(has_value(empty_id, "g0", "d"));
+    ::jnp1::dict_insert(::jnp1::dict_global(), "g1", "e");
+    assert(::jnp1::dict_size(::jnp1::dict_global()) == 2);
+    assert(has_value(id, "g1", "e"));
+    ::jnp1::dict_clear(::jnp1::dict_global());
+
+    ::jnp1::dict_delete(id);
+    ::jnp1::dict_delete(copy_id);
+    ::jnp1::dict_delete(empty_id);
+    return 0;
+}
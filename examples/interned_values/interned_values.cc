@@ -0,0 +1,70 @@
+#include <cassert>
+#include <cstring>
+#include "cdict"
+
+namespace {
+    [[maybe_unused]] bool has_value(unsigned long id, const char* key, const char* value) {
+        const char* found = ::jnp1::dict_find(id, key);
+        return found != NULL && strcmp(found, value) == 0;
+    }
+}
+
+int main() {
+    const unsigned long id1 = ::jnp1::dict_new();
+    const unsigned long id2 = ::jnp1::dict_new();
+
+    ::jnp1::dict_insert(id1, "status", "running");
+    ::jnp1::dict_insert(id2, "state", "running");
+    ::jnp1::dict_insert(id2, "other", "stopped");
+
+    [[maybe_unused]] const char* value1 = ::jnp1::dict_find(id1, "status");
+    [[maybe_unused]] const char* value2 = ::jnp1::dict_find(id2, "state");
+    assert(strcmp(value1, "running") == 0);
+    assert(strcmp(value2, "running") == 0);
+
+#if DICT_INTERN_VALUES
+    // Equal values are stored once
+    assert(value1 == value2);
+#endif
+
+    // Removal from one dictionary keeps the value of the other
+    ::jnp1::dict_remove(id1, "status");
+    assert(::jnp1::dict_find(id1, "status") == NULL);
+    assert(strcmp(value2, "running") == 0);
+    assert(::jnp1::dict_find(id2, "state") == value2);
+
+    // Copies share values
+    const unsigned long id3 = ::jnp1::dict_new();
+    ::jnp1::dict_copy(id2, id3);
+#if DICT_INTERN_VALUES
+    assert(::jnp1::dict_find(id3, "state") == value2);
+#endif
+    ::jnp1::dict_delete(id2);
+    assert(has_value(id3, "state", "running"));
+    assert(has_value(id3, "other", "stopped"));
+
+    // Upsert drops only its own reference
+    const unsigned long id4 = ::jnp1::dict_new();
+    ::jnp1::dict_insert(id4, "state", "running");
+    ::jnp1::dict_upsert(id3, "state", "stopped");
+    assert(has_value(id3, "state", "stopped"));
+    assert(has_value(id4, "state", "running"));
+#if DICT_INTERN_VALUES
+    assert(::jnp1::dict_find(id3, "state") == ::jnp1::dict_find(id3, "other"));
+#endif
+
+    // Upsert of the same value keeps it alive
+    ::jnp1::dict_upsert(id4, "state", "running");
+    assert(has_value(id4, "state", "running"));
+
+    // Values live as long as any dictionary holds them
+    ::jnp1::dict_clear(id3);
+    assert(has_value(id4, "state", "running"));
+    ::jnp1::dict_delete(id4);
+    ::jnp1::dict_insert(id3, "state", "running");
+    assert(has_value(id3, "state", "running"));
+
+    ::jnp1::dict_delete(id1);
+    ::jnp1::dict_delete(id3);
+    return 0;
+}
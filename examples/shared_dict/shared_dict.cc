@@ -0,0 +1,78 @@
+#include <cassert>
+#include <cstring>
+#include <string>
+#include <sys/wait.h>
+#include <unistd.h>
+#include "cdict"
+
+namespace {
+    const char* SEGMENT_NAME = "/jnp1_shared_dict_example";
+    const int RECORDS_COUNT = 100;
+
+    std::string key(int i) {
+        return "k" + std::to_string(i);
+    }
+
+    std::string value(int i) {
+        return "v" + std::to_string(i % 10);
+    }
+
+    // Runs in the child process, returns its exit code
+    int read_shared() {
+        const unsigned long id = ::jnp1::dict_attach(SEGMENT_NAME);
+        assert(id != 0);
+        assert(::jnp1::dict_size(id) == RECORDS_COUNT);
+
+        for (int i = 0; i < RECORDS_COUNT; ++i) {
+            assert(strcmp(::jnp1::dict_find(id, key(i).c_str()), value(i).c_str()) == 0);
+        }
+        assert(::jnp1::dict_find(id, "missing") == NULL);
+
+        // Attached dictionaries are read-only
+        ::jnp1::dict_insert(id, "new", "a");
+        ::jnp1::dict_upsert(id, "k0", "b");
+        ::jnp1::dict_remove(id, "k1");
+        ::jnp1::dict_clear(id);
+        assert(::jnp1::dict_size(id) == RECORDS_COUNT);
+        assert(::jnp1::dict_find(id, "new") == NULL);
+        assert(strcmp(::jnp1::dict_find(id, "k0"), "v0") == 0);
+
+        // Copies are mutable
+        const unsigned long copy_id = ::jnp1::dict_new();
+        ::jnp1::dict_copy(id, copy_id);
+        ::jnp1::dict_insert(copy_id, "new", "a");
+        assert(::jnp1::dict_size(copy_id) == RECORDS_COUNT + 1);
+
+        ::jnp1::dict_delete(id);
+        assert(::jnp1::dict_size(id) == 0);
+        return 0;
+    }
+}
+
+int main() {
+    const unsigned long id = ::jnp1::dict_new();
+    for (int i = 0; i < RECORDS_COUNT; ++i) {
+        ::jnp1::dict_insert(id, key(i).c_str(), value(i).c_str());
+    }
+
+    [[maybe_unused]] const int shared = ::jnp1::dict_share(id, SEGMENT_NAME);
+    assert(shared == 1);
+
+    const pid_t child = fork();
+    assert(child >= 0);
+    if (child == 0) {
+        _exit(read_shared());
+    }
+
+    int status = 0;
+    [[maybe_unused]] const pid_t waited = waitpid(child, &status, 0);
+    assert(waited == child);
+    assert(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+
+    ::jnp1::dict_unshare(SEGMENT_NAME);
+    [[maybe_unused]] const unsigned long unshared_id = ::jnp1::dict_attach(SEGMENT_NAME);
+    assert(unshared_id == 0);
+
+    ::jnp1::dict_delete(id);
+    return 0;
+}
@@ -0,0 +1,155 @@
+#include <cassert>
+#include <cstring>
+#include <string>
+#include "cdict"
+#include "cdictglobal"
+
+#if DICT_THREAD_SAFE
+#include <thread>
+#include <vector>
+#endif
+
+namespace {
+    [[maybe_unused]] bool has_value(unsigned long id, const char* key, const char* value) {
+        const char* found = ::jnp1::dict_find(id, key);
+        return found != NULL && strcmp(found, value) == 0;
+    }
+
+    // Increments the number saved under the key with read-modify-write loop
+    void increment(unsigned long id, const char* key) {
+        char current[32];
+        for (;;) {
+            [[maybe_unused]] const size_t copied = ::jnp1::dict_find_copy(id, key, current, sizeof(current));
+            assert(copied != 0);
+            const std::string next = std::to_string(std::stoi(current) + 1);
+            if (::jnp1::dict_compare_and_swap(id, key, current, next.c_str())) {
+                return;
+            }
+        }
+    }
+}
+
+int main() {
+    const unsigned long id = ::jnp1::dict_new();
+
+    // Upsert inserts and overwrites
+    ::jnp1::dict_upsert(id, "a", "1");
+    ::jnp1::dict_upsert(id, "a", "22");
+    assert(has_value(id, "a", "22"));
+    assert(::jnp1::dict_size(id) == 1);
+    ::jnp1::dict_upsert(id, NULL, "1");
+    ::jnp1::dict_upsert(id, "b", NULL);
+    assert(::jnp1::dict_size(id) == 1);
+
+    // Find or insert returns the stored value
+    [[maybe_unused]] const char* found_a = ::jnp1::dict_find_or_insert(id, "a", "9");
+    assert(strcmp(found_a, "22") == 0);
+    [[maybe_unused]] const char* inserted_b = ::jnp1::dict_find_or_insert(id, "b", "3");
+    assert(strcmp(inserted_b, "3") == 0);
+    assert(::jnp1::dict_size(id) == 2);
+
+    // Copying values out
+    char buffer[8];
+    [[maybe_unused]] size_t value_size = ::jnp1::dict_find_copy(id, "a", buffer, sizeof(buffer));
+    assert(value_size == 3);
+    assert(strcmp(buffer, "22") == 0);
+    value_size = ::jnp1::dict_find_copy(id, "a", buffer, 2);
+    assert(value_size == 3);
+    assert(strcmp(buffer, "2") == 0);
+    value_size = ::jnp1::dict_find_copy(id, "a", NULL, 0);
+    assert(value_size == 3);
+    value_size = ::jnp1::dict_find_copy(id, "missing", buffer, sizeof(buffer));
+    assert(value_size == 0);
+
+    // Compare and swap
+    [[maybe_unused]] int swapped = ::jnp1::dict_compare_and_swap(id, "a", "1", "5");
+    assert(!swapped);
+    swapped = ::jnp1::dict_compare_and_swap(id, "a", "22", "5");
+    assert(swapped);
+    assert(has_value(id, "a", "5"));
+    swapped = ::jnp1::dict_compare_and_swap(id, "missing", "5", "6");
+    assert(!swapped);
+    assert(::jnp1::dict_find(id, "missing") == NULL);
+
+    // NULL expected value means that the key is absent
+    swapped = ::jnp1::dict_compare_and_swap(id, "c", NULL, "1");
+    assert(swapped);
+    swapped = ::jnp1::dict_compare_and_swap(id, "c", NULL, "2");
+    assert(!swapped);
+    assert(has_value(id, "c", "1"));
+
+    // Stale pointer returned by dict_find never matches
+    // (interned values are freed instead of being replaced in place)
+#if !DICT_INTERN_VALUES
+    const char* stale = ::jnp1::dict_find(id, "c");
+    swapped = ::jnp1::dict_compare_and_swap(id, "c", "1", "2");
+    assert(swapped);
+    swapped = ::jnp1::dict_compare_and_swap(id, "c", stale, "3");
+    assert(!swapped);
+#else
+    swapped = ::jnp1::dict_compare_and_swap(id, "c", "1", "2");
+    assert(swapped);
+#endif
+    assert(has_value(id, "c", "2"));
+
+    // Frozen dictionary is thawed
+    ::jnp1::dict_freeze(id);
+    ::jnp1::dict_upsert(id, "a", "6");
+    assert(has_value(id, "a", "6"));
+    ::jnp1::dict_freeze(id);
+    [[maybe_unused]] const char* inserted_d = ::jnp1::dict_find_or_insert(id, "d", "7");
+    assert(strcmp(inserted_d, "7") == 0);
+    ::jnp1::dict_freeze(id);
+    swapped = ::jnp1::dict_compare_and_swap(id, "d", "7", "8");
+    assert(swapped);
+    assert(has_value(id, "d", "8"));
+    assert(::jnp1::dict_size(id) == 4);
+
+    // Full global dictionary only accepts existing keys
+    const unsigned long global_id = ::jnp1::dict_global();
+    for (unsigned long i = 0; i < ::jnp1::MAX_GLOBAL_DICT_SIZE; ++i) {
+        ::jnp1::dict_upsert(global_id, ("g" + std::to_string(i)).c_str(), "x");
+    }
+    assert(::jnp1::dict_size(global_id) == ::jnp1::MAX_GLOBAL_DICT_SIZE);
+    ::jnp1::dict_upsert(global_id, "extra", "x");
+    [[maybe_unused]] const char* inserted_extra = ::jnp1::dict_find_or_insert(global_id, "extra", "x");
+    assert(inserted_extra == NULL);
+    swapped = ::jnp1::dict_compare_and_swap(global_id, "extra", NULL, "x");
+    assert(!swapped);
+    assert(::jnp1::dict_size(global_id) == ::jnp1::MAX_GLOBAL_DICT_SIZE);
+    ::jnp1::dict_upsert(global_id, "g0", "y");
+    assert(has_value(global_id, "g0", "y"));
+    [[maybe_unused]] const char* found_g1 = ::jnp1::dict_find_or_insert(global_id, "g1", "z");
+    assert(strcmp(found_g1, "x") == 0);
+    swapped = ::jnp1::dict_compare_and_swap(global_id, "g1", "x", "z");
+    assert(swapped);
+    value_size = ::jnp1::dict_find_copy(id, "g1", buffer, sizeof(buffer));
+    assert(value_size == 2);
+    assert(strcmp(buffer, "z") == 0);
+    ::jnp1::dict_clear(global_id);
+
+    // Counter incremented from many threads
+    ::jnp1::dict_upsert(id, "counter", "0");
+#if DICT_THREAD_SAFE
+    const int THREADS_COUNT = 4;
+    const int INCREMENTS_COUNT = 2000;
+    std::vector<std::thread> threads;
+    for (int i = 0; i < THREADS_COUNT; ++i) {
+        threads.emplace_back([id]() {
+            for (int j = 0; j < INCREMENTS_COUNT; ++j) {
+                increment(id, "counter");
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    assert(has_value(id, "counter", std::to_string(THREADS_COUNT * INCREMENTS_COUNT).c_str()));
+#else
+    increment(id, "counter");
+    assert(has_value(id, "counter", "1"));
+#endif
+
+    ::jnp1::dict_delete(id);
+    return 0;
+}
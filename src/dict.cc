@@ -9,6 +9,8 @@
  */
  
 #include <cstddef>
+#include <algorithm>
+#include <string_view>
 #include <unordered_map>
 #include <map>
 #include <vector>
@@ -17,6 +19,20 @@
 #include <cassert>
 #include <cstdarg>
 #include <ostream>
+#include <cstdint>
+#include <cstring>
+#include <atomic>
+#include <memory>
+#include <new>
+#include <random>
+#include <mutex>
+#include <shared_mutex>
+#include <type_traits>
+#include <string>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 
 extern "C" {
 
@@ -36,6 +52,30 @@ extern "C" {
     // Disable debugging
     constexpr bool DEBUG = false;
   
+#endif
+
+#if defined(DICT_THREAD_SAFE) && DICT_THREAD_SAFE
+
+    // Guard the dictionaries with a lock
+    constexpr bool THREAD_SAFE = true;
+
+#else
+
+    // No locking
+    constexpr bool THREAD_SAFE = false;
+
+#endif
+
+#if defined(DICT_INTERN_VALUES) && DICT_INTERN_VALUES
+
+    // Share equal values between all dictionaries
+    constexpr bool INTERN_VALUES = true;
+
+#else
+
+    // Each record owns its value
+    constexpr bool INTERN_VALUES = false;
+
 #endif
 
     constexpr bool USE_ID_COMPACT_ALLOC_MODE = false;
@@ -187,10 +227,422 @@ extern "C" {
             return out;
         }
      
+        /*
+         * wyhash (final version 4, public domain by Wang Yi).
+         *
+         * Fast 64-bit multiply-mix hash. The seed is mixed
+         * into every round so collisions cannot be
+         * precomputed without knowing it.
+         */
+        struct WyHasher {
+            static constexpr std::uint32_t ID = 1;
+            
+            static void mum(std::uint64_t& a, std::uint64_t& b) {
+                const __uint128_t r = static_cast<__uint128_t>(a) * b;
+                a = static_cast<std::uint64_t>(r);
+                b = static_cast<std::uint64_t>(r >> 64);
+            }
+            
+            static std::uint64_t mix(std::uint64_t a, std::uint64_t b) {
+                mum(a, b);
+                return a ^ b;
+            }
+            
+            static std::uint64_t read8(const unsigned char* p) {
+                std::uint64_t v;
+                std::memcpy(&v, p, sizeof(v));
+                return v;
+            }
+            
+            static std::uint64_t read4(const unsigned char* p) {
+                std::uint32_t v;
+                std::memcpy(&v, p, sizeof(v));
+                return v;
+            }
+            
+            static std::uint64_t read3(const unsigned char* p, const std::size_t k) {
+                return (static_cast<std::uint64_t>(p[0]) << 16)
+                    | (static_cast<std::uint64_t>(p[k >> 1]) << 8) | p[k - 1];
+            }
+            
+            static std::uint64_t hash(const char* data, const std::size_t length, std::uint64_t seed) {
+                static constexpr std::uint64_t secret[4] = {
+                    0x2d358dccaa6c78a5ULL, 0x8bb84b93962eacc9ULL,
+                    0x4b33a62ed433d4a3ULL, 0x4d5a2da51de1aa47ULL
+                };
+                
+                const unsigned char* p = reinterpret_cast<const unsigned char*>(data);
+                seed ^= mix(seed ^ secret[0], secret[1]);
+                std::uint64_t a, b;
+                
+                if(length <= 16) {
+                    if(length >= 4) {
+                        a = (read4(p) << 32) | read4(p + ((length >> 3) << 2));
+                        b = (read4(p + length - 4) << 32) | read4(p + length - 4 - ((length >> 3) << 2));
+                    } else if(length > 0) {
+                        a = read3(p, length);
+                        b = 0;
+                    } else {
+                        a = b = 0;
+                    }
+                } else {
+                    std::size_t i = length;
+                    if(i > 48) {
+                        std::uint64_t seed1 = seed, seed2 = seed;
+                        do {
+                            seed = mix(read8(p) ^ secret[1], read8(p + 8) ^ seed);
+                            seed1 = mix(read8(p + 16) ^ secret[2], read8(p + 24) ^ seed1);
+                            seed2 = mix(read8(p + 32) ^ secret[3], read8(p + 40) ^ seed2);
+                            p += 48;
+                            i -= 48;
+                        } while(i > 48);
+                        seed ^= seed1 ^ seed2;
+                    }
+                    while(i > 16) {
+                        seed = mix(read8(p) ^ secret[1], read8(p + 8) ^ seed);
+                        i -= 16;
+                        p += 16;
+                    }
+                    a = read8(p + i - 16);
+                    b = read8(p + i - 8);
+                }
+                
+                a ^= secret[1];
+                b ^= seed;
+                mum(a, b);
+                return mix(a ^ secret[0] ^ length, b ^ secret[1]);
+            }
+        };
+        
+        /*
+         * Seeded 64-bit FNV-1a.
+         *
+         * Simple and portable, but the seed only changes
+         * the offset basis, so it is much weaker against
+         * crafted collisions than wyhash.
+         */
+        struct Fnv1aHasher {
+            static constexpr std::uint32_t ID = 2;
+            
+            static std::uint64_t hash(const char* data, const std::size_t length, const std::uint64_t seed) {
+                std::uint64_t hash = 0xcbf29ce484222325ULL ^ seed;
+                for(std::size_t i = 0; i < length; ++i) {
+                    hash ^= static_cast<unsigned char>(data[i]);
+                    hash *= 0x100000001b3ULL;
+                }
+                return hash;
+            }
+        };
+        
+        // Hash function used by dictionaries
+        // Selected at compile time with -DDICT_HASH=DICT_HASH_<name>
+        // (see DICT_HASH in the makefile), wyhash by default
+#define DICT_HASH_WYHASH 1
+#define DICT_HASH_FNV1A 2
+
+#if !defined(DICT_HASH) || DICT_HASH == DICT_HASH_WYHASH
+        typedef WyHasher KeyHasher;
+#elif DICT_HASH == DICT_HASH_FNV1A
+        typedef Fnv1aHasher KeyHasher;
+#else
+#error "Unsupported hash function, build with DICT_HASH=WYHASH or DICT_HASH=FNV1A"
+#endif
+        
+        /*
+         * Returns new random seed.
+         *
+         * @returns random 64-bit seed
+         */
+        std::uint64_t get_random_seed() {
+            std::random_device device;
+            return (static_cast<std::uint64_t>(device()) << 32) ^ device();
+        }
+        
+        /*
+         * Returns the random hash seed of this process.
+         * Keys sent by an attacker cannot be chosen to collide
+         * without knowing the seed.
+         *
+         * The seed is never written anywhere
+         * (images get seeds of their own).
+         *
+         * @returns hash seed
+         */
+        std::uint64_t get_hash_seed() {
+            static const std::uint64_t seed = get_random_seed();
+            return seed;
+        }
+        
+        /*
+         * Dictionary key with its hash computed once
+         * (with the seed of this process).
+         * 
+         * Rehashing reuses the stored hash and comparing
+         * keys with different hashes skips comparing the strings.
+         */
+        struct HashedKey {
+            std::string text;
+            std::uint64_t hash;
+            
+            explicit HashedKey(std::string key_text)
+                : text(std::move(key_text)),
+                  hash(KeyHasher::hash(text.data(), text.size(), get_hash_seed())) {}
+        };
+        
+        struct HashedKeyHash {
+            std::size_t operator()(const HashedKey& key) const noexcept {
+                return static_cast<std::size_t>(key.hash);
+            }
+        };
+        
+        struct HashedKeyEqual {
+            bool operator()(const HashedKey& a, const HashedKey& b) const noexcept {
+                return a.hash == b.hash && a.text == b.text;
+            }
+        };
+        
+        /*
+         * Value stored once in the string pool
+         * and shared by all equal InternedValues.
+         */
+        struct PooledString {
+            std::string text;
+            std::size_t references;
+        };
+        
+        struct PooledStringHash {
+            std::size_t operator()(const std::string_view text) const noexcept {
+                return static_cast<std::size_t>(KeyHasher::hash(text.data(), text.size(), get_hash_seed()));
+            }
+        };
+        
+        // Pool keys point to the text of the pooled strings
+        typedef std::unordered_map<std::string_view,
+            std::unique_ptr<PooledString>, PooledStringHash> StringPool;
+        
+        /*
+         * Returns the pool of interned values.
+         *
+         * The pool is never destroyed, as the dictionaries
+         * holding its strings may be destroyed after it at exit.
+         *
+         * @returns StringPool object
+         */
+        StringPool& get_string_pool() {
+            static StringPool* pool = new StringPool();
+            return *pool;
+        }
+        
+        /*
+         * Returns the pooled copy of the text
+         * (adding it to the pool if needed) and references it.
+         *
+         * @param[in] text : value text
+         * @returns pooled string
+         */
+        PooledString* acquire_pooled_string(const std::string_view text) {
+            StringPool& pool = get_string_pool();
+            
+            const StringPool::iterator i = pool.find(text);
+            if(i != pool.end()) {
+                ++i->second->references;
+                return i->second.get();
+            }
+            
+            std::unique_ptr<PooledString> pooled(new PooledString{ std::string(text), 1 });
+            PooledString* result = pooled.get();
+            pool.emplace(std::string_view(result->text), std::move(pooled));
+            return result;
+        }
+        
+        /*
+         * Drops the reference to pooled string.
+         * Removes it from the pool when it's no longer used.
+         *
+         * @param[in] pooled : pooled string
+         */
+        void release_pooled_string(PooledString* pooled) {
+            if(--pooled->references == 0) {
+                get_string_pool().erase(std::string_view(pooled->text));
+            }
+        }
+        
+        /*
+         * Dictionary value kept in the string pool.
+         * Equal values of all dictionaries share one copy,
+         * so copying the value only counts the reference.
+         *
+         * Values are created, copied and destroyed only by functions
+         * holding DictWriteLock, so the pool needs no other lock.
+         */
+        class InternedValue {
+            PooledString* pooled;
+            
+        public:
+            InternedValue(const char* text) : pooled(acquire_pooled_string(text)) {}
+            
+            InternedValue(const std::string& text) : pooled(acquire_pooled_string(text)) {}
+            
+            InternedValue(const InternedValue& other) : pooled(other.pooled) {
+                ++pooled->references;
+            }
+            
+            ~InternedValue() {
+                release_pooled_string(pooled);
+            }
+            
+            InternedValue& operator=(const InternedValue& other) {
+                ++other.pooled->references;
+                release_pooled_string(pooled);
+                pooled = other.pooled;
+                return *this;
+            }
+            
+            InternedValue& operator=(const char* text) {
+                PooledString* replacement = acquire_pooled_string(text);
+                release_pooled_string(pooled);
+                pooled = replacement;
+                return *this;
+            }
+            
+            bool operator!=(const char* text) const {
+                return pooled->text != text;
+            }
+            
+            const char* c_str() const {
+                return pooled->text.c_str();
+            }
+            
+            std::size_t size() const {
+                return pooled->text.size();
+            }
+        };
+        
+        // Type of dictionary values
+        // Selected at compile time with -DDICT_INTERN_VALUES=1
+        // (see DICT_INTERN_VALUES in the makefile)
+        typedef std::conditional<INTERN_VALUES, InternedValue, std::string>::type DictValue;
+     
         // Type definitions
-        typedef std::unordered_map<std::string, std::string> Dict;
+        typedef std::unordered_map<HashedKey, DictValue, HashedKeyHash, HashedKeyEqual> Dict;
         typedef Dict::const_iterator DictConstIterator;
-        typedef std::map<unsigned long, Dict> DictContainer;
+        
+        /*
+         * Header of read-only dictionary image.
+         *
+         * The image is a single contiguous block:
+         *
+         *   [header][displacements][entries][keys][values]
+         *
+         * Records are placed with minimal perfect hash
+         * (hash and displace): the key hash selects a displacement
+         * and the displacement mixed with the hash selects
+         * the only entry that may hold the key.
+         * Equal values are stored only once.
+         *
+         * All references inside it are offsets from the beginning
+         * of the block, so it can be mapped at any address
+         * (e.g. in shared memory of another process).
+         */
+        struct DictImageHeader {
+            std::uint32_t magic;
+            std::uint32_t version;
+            std::atomic<std::uint32_t> ready;
+            std::uint32_t hash_function;
+            std::uint64_t hash_seed;
+            std::uint64_t total_size;
+            std::uint64_t entries_count;
+            std::uint64_t displacement_count;
+            std::uint64_t displacements_offset;
+            std::uint64_t entries_offset;
+        };
+        
+        /*
+         * Single record of dictionary image.
+         * Key and value are null-terminated strings
+         * at the given offsets.
+         */
+        struct DictImageEntry {
+            std::uint64_t hash;
+            std::uint64_t key_offset;
+            std::uint64_t value_offset;
+            std::uint32_t key_length;
+            std::uint32_t value_length;
+        };
+        
+        static_assert(std::atomic<std::uint32_t>::is_always_lock_free,
+            "Image ready flag must be usable across processes");
+        
+        constexpr std::uint32_t DICT_IMAGE_MAGIC = 0x54434944;
+        constexpr std::uint32_t DICT_IMAGE_VERSION = 4;
+        
+        // Average number of records sharing one displacement
+        constexpr std::size_t DICT_IMAGE_RECORDS_PER_DISPLACEMENT = 4;
+        
+        // Number of seeds tried before giving up building the image
+        constexpr unsigned DICT_IMAGE_SEED_ATTEMPTS = 8;
+        
+        /*
+         * Read-only dictionary image.
+         * storage is the beginning of the image block
+         * and owns the underlying memory (e.g. the mapping).
+         */
+        struct DictImage {
+            std::shared_ptr<const char> storage;
+            
+            const DictImageHeader* header() const {
+                return reinterpret_cast<const DictImageHeader*>(storage.get());
+            }
+            
+            const std::uint32_t* displacements() const {
+                return reinterpret_cast<const std::uint32_t*>(
+                    storage.get() + header()->displacements_offset);
+            }
+            
+            const DictImageEntry* entries() const {
+                return reinterpret_cast<const DictImageEntry*>(
+                    storage.get() + header()->entries_offset);
+            }
+            
+            const char* text(const std::uint64_t offset) const {
+                return storage.get() + offset;
+            }
+        };
+        
+        /*
+         * Plan of the dictionary image.
+         * Built before writing, so the size of image
+         * is known before the memory is allocated.
+         */
+        struct DictImageLayout {
+            std::uint64_t hash_seed;
+            std::vector<std::uint32_t> displacements;
+            std::vector<const Dict::value_type*> slots;
+            std::vector<std::uint64_t> hashes;
+            std::vector<std::uint64_t> value_offsets;
+            std::uint64_t keys_offset;
+            std::uint64_t total_size;
+        };
+        
+        /*
+         * Dictionary stored in the container.
+         *
+         * If the image is present all its records live in the image.
+         * Frozen dictionaries (with own image) are thawed
+         * back to entries on modification,
+         * shared ones (attached with dict_attach) are read-only.
+         */
+        struct DictRecord {
+            Dict entries;
+            DictImage image;
+            bool is_shared = false;
+            
+            bool is_image() const {
+                return image.storage != nullptr;
+            }
+        };
+        
+        typedef std::map<unsigned long, DictRecord> DictContainer;
         typedef DictContainer::const_iterator DictContainerConstIterator;
         
         /*
@@ -217,54 +669,649 @@ extern "C" {
             const DictContainerConstIterator i = get_dict_container().find(id);
             return (i != get_dict_container().end());
         }
-      
-    } //anonymous namespace
-       
-     
-    // Create new dict and return its id
-    // If  is ON then ids are reused
-    // (after dictionary removal)
-    // If not then id assigned once (and even deleted) is never
-    // used again.
-    unsigned long dict_new() {
         
-        log("%{function_name}()\n");
+        /*
+         * Returns the existing dictionary without
+         * modifying the container (unlike operator[]),
+         * so it's safe for concurrent readers.
+         *
+         * @param[in] id : id of existing dictionary
+         * @returns DictRecord object
+         */
+        const DictRecord& get_record(const unsigned long& id) {
+            const DictContainerConstIterator i = get_dict_container().find(id);
+            
+            // The dictionary must exist
+            assert(i != get_dict_container().end());
+            
+            return i->second;
+        }
         
-        // Find first free id in the container
-        static unsigned long global_id_counter = 1;
-        unsigned long free_id = 0;
+        /*
+         * Returns the lock of dictionaries container.
+         *
+         * @returns std::shared_mutex object
+         */
+        std::shared_mutex& get_dict_mutex() {
+            static std::shared_mutex mutex;
+            return mutex;
+        }
         
-        if(USE_ID_COMPACT_ALLOC_MODE) {
-            unsigned long last_id = 0;
-            bool free_id_found = false;
+        /*
+         * Shared lock of dictionaries container,
+         * taken by functions that only read dictionaries.
+         * Does nothing unless built with DICT_THREAD_SAFE.
+         */
+        class DictReadLock {
+            std::shared_lock<std::shared_mutex> lock;
             
-            for ( const auto &dict : get_dict_container() ) {
-                if(dict.first != 0 && dict.first != last_id+1) {
-                    free_id = last_id+1;
-                    free_id_found = true;
-                    break;
+        public:
+            DictReadLock() : lock(get_dict_mutex(), std::defer_lock) {
+                if(THREAD_SAFE) lock.lock();
+            }
+        };
+        
+        /*
+         * Exclusive lock of dictionaries container,
+         * taken by functions that modify dictionaries.
+         * Does nothing unless built with DICT_THREAD_SAFE.
+         */
+        class DictWriteLock {
+            std::unique_lock<std::shared_mutex> lock;
+            
+        public:
+            DictWriteLock() : lock(get_dict_mutex(), std::defer_lock) {
+                if(THREAD_SAFE) lock.lock();
+            }
+        };
+        
+        /*
+         * Inserts the key if it's not present in the dictionary.
+         * Records are never added to full global dictionary.
+         * The key is looked up only once.
+         *
+         * @param[in] id    : id of mutable dictionary
+         * @param[in] key   : key of entry
+         * @param[in] value : value inserted if the key is absent
+         * @returns pair of (entry or end if the global dictionary is full,
+         *          if the entry was inserted?)
+         */
+        std::pair<Dict::iterator, bool> try_insert(const unsigned long& id,
+            const char* key, const char* value) {
+            Dict& dict = get_dict_container()[id].entries;
+            
+            // Global dictionary has maximum size MAX_GLOBAL_DICT_SIZE
+            // so when it's full only existing keys are found
+            if(id == 0 && dict.size() >= MAX_GLOBAL_DICT_SIZE) {
+                return { dict.find(HashedKey(key)), false };
+            }
+            return dict.try_emplace(HashedKey(key), value);
+        }
+        
+        /*
+         * Returns the hash of the key as stored in the image.
+         * Images are hashed with their own random seed,
+         * as they may be readable by other processes.
+         *
+         * @param[in] header : header of dictionary image
+         * @param[in] key    : hashed key
+         * @returns hash of the key in the image
+         */
+        std::uint64_t hash_image_key(const DictImageHeader* header, const HashedKey& key) {
+            return KeyHasher::hash(key.text.data(), key.text.size(), header->hash_seed);
+        }
+        
+        /*
+         * Maps the hash uniformly to [0, range).
+         *
+         * @param[in] hash  : 64-bit hash
+         * @param[in] range : size of the range
+         * @returns number from the range
+         */
+        std::uint64_t reduce_hash(const std::uint64_t hash, const std::uint64_t range) {
+            return static_cast<std::uint64_t>((static_cast<__uint128_t>(hash) * range) >> 64);
+        }
+        
+        /*
+         * Mixes all bits of the hash (splitmix64 finalizer),
+         * so weak hash functions (like FNV-1a, whose high bits
+         * hardly depend on the last characters) spread well.
+         *
+         * @param[in] hash : 64-bit hash
+         * @returns mixed hash
+         */
+        std::uint64_t mix_image_hash(std::uint64_t hash) {
+            hash = (hash ^ (hash >> 30)) * 0xbf58476d1ce4e5b9ULL;
+            hash = (hash ^ (hash >> 27)) * 0x94d049bb133111ebULL;
+            return hash ^ (hash >> 31);
+        }
+        
+        /*
+         * Returns the index of displacement used by the key.
+         *
+         * @param[in] hash               : hash of the key
+         * @param[in] displacement_count : number of displacements
+         * @returns displacement index
+         */
+        std::uint64_t get_image_displacement_index(const std::uint64_t hash,
+            const std::uint64_t displacement_count) {
+            return reduce_hash(mix_image_hash(hash), displacement_count);
+        }
+        
+        /*
+         * Returns the index of entry that may hold the key.
+         *
+         * @param[in] hash          : hash of the key
+         * @param[in] displacement  : displacement of the key
+         * @param[in] entries_count : number of records
+         * @returns entry index
+         */
+        std::uint64_t get_image_slot(const std::uint64_t hash,
+            const std::uint32_t displacement, const std::uint64_t entries_count) {
+            const std::uint64_t x = mix_image_hash(hash + (displacement + 1ULL) * 0x9e3779b97f4a7c15ULL);
+            return reduce_hash(x, entries_count);
+        }
+        
+        /*
+         * Rounds size up to the alignment of image entries.
+         *
+         * @param[in] size : size in bytes
+         * @returns aligned size
+         */
+        constexpr std::size_t align_image_size(const std::size_t size) {
+            return (size + alignof(DictImageEntry) - 1) & ~(alignof(DictImageEntry) - 1);
+        }
+        
+        /*
+         * Finds displacements placing each record in a distinct entry.
+         * Groups with more records are placed first,
+         * while most of the entries are still free.
+         *
+         * @param[in]  hashes        : hashes of the records
+         * @param[out] displacements : found displacements
+         * @param[out] slots         : index of record held by each entry
+         * @returns If all the records were placed?
+         */
+        bool place_image_records(const std::vector<std::uint64_t>& hashes,
+            std::vector<std::uint32_t>& displacements, std::vector<std::size_t>& slots) {
+            
+            const std::size_t entries_count = hashes.size();
+            
+            std::vector<std::vector<std::size_t>> groups(displacements.size());
+            for(std::size_t i = 0; i < entries_count; ++i) {
+                groups[get_image_displacement_index(hashes[i], displacements.size())].push_back(i);
+            }
+            
+            std::vector<std::size_t> order(groups.size());
+            for(std::size_t i = 0; i < order.size(); ++i) {
+                order[i] = i;
+            }
+            std::stable_sort(order.begin(), order.end(), [&groups](std::size_t a, std::size_t b) {
+                return groups[a].size() > groups[b].size();
+            });
+            
+            const std::size_t EMPTY = entries_count;
+            slots.assign(entries_count, EMPTY);
+            
+            // Expected number of attempts for the last group is entries_count
+            const std::uint64_t max_displacement = 16 * static_cast<std::uint64_t>(entries_count) + 1024;
+            std::vector<std::uint64_t> group_slots;
+            
+            for(const std::size_t group_index : order) {
+                const std::vector<std::size_t>& group = groups[group_index];
+                if(group.empty()) break;
+                
+                bool placed = false;
+                for(std::uint64_t displacement = 0; !placed && displacement < max_displacement; ++displacement) {
+                    group_slots.clear();
+                    placed = true;
+                    for(const std::size_t record : group) {
+                        const std::uint64_t slot = get_image_slot(hashes[record],
+                            static_cast<std::uint32_t>(displacement), entries_count);
+                        if(slots[slot] != EMPTY
+                            || std::find(group_slots.begin(), group_slots.end(), slot) != group_slots.end()) {
+                            placed = false;
+                            break;
+                        }
+                        group_slots.push_back(slot);
+                    }
+                    
+                    if(placed) {
+                        displacements[group_index] = static_cast<std::uint32_t>(displacement);
+                        for(std::size_t i = 0; i < group.size(); ++i) {
+                            slots[group_slots[i]] = group[i];
+                        }
+                    }
                 }
-                last_id = dict.first;
+                
+                // Records with equal hashes can never be separated
+                if(!placed) return false;
             }
             
-            if(!free_id_found) {
-                free_id = last_id+1;
+            return true;
+        }
+        
+        /*
+         * Plans the image of given dictionary.
+         *
+         * Records are hashed with new random seed, independent
+         * of the seed of this process, which must stay secret.
+         * If they cannot be placed then other random seeds are tried.
+         *
+         * @param[in]  dict   : source dictionary
+         * @param[out] layout : planned image
+         * @returns If the image could be planned?
+         */
+        bool plan_image(const Dict& dict, DictImageLayout& layout) {
+            std::vector<const Dict::value_type*> records;
+            records.reserve(dict.size());
+            for(const auto& record : dict) {
+                records.push_back(&record);
             }
-        } else {
-            free_id = global_id_counter;
-            ++global_id_counter;
+            
+            const std::size_t displacement_count = std::max<std::size_t>(1,
+                (dict.size() + DICT_IMAGE_RECORDS_PER_DISPLACEMENT - 1) / DICT_IMAGE_RECORDS_PER_DISPLACEMENT);
+            std::vector<std::uint64_t> hashes(records.size());
+            std::vector<std::size_t> slots;
+            
+            bool placed = false;
+            for(unsigned attempt = 0; !placed && attempt < DICT_IMAGE_SEED_ATTEMPTS; ++attempt) {
+                layout.hash_seed = get_random_seed();
+                for(std::size_t i = 0; i < records.size(); ++i) {
+                    const HashedKey& key = records[i]->first;
+                    hashes[i] = KeyHasher::hash(key.text.data(), key.text.size(), layout.hash_seed);
+                }
+                layout.displacements.assign(displacement_count, 0);
+                placed = place_image_records(hashes, layout.displacements, slots);
+            }
+            if(!placed) return false;
+            
+            layout.slots.resize(records.size());
+            layout.hashes.resize(records.size());
+            for(std::size_t slot = 0; slot < slots.size(); ++slot) {
+                layout.slots[slot] = records[slots[slot]];
+                layout.hashes[slot] = hashes[slots[slot]];
+            }
+            
+            std::uint64_t offset = align_image_size(sizeof(DictImageHeader));
+            offset += align_image_size(displacement_count * sizeof(std::uint32_t));
+            offset += records.size() * sizeof(DictImageEntry);
+            
+            layout.keys_offset = offset;
+            for(const auto* record : layout.slots) {
+                offset += record->first.text.size() + 1;
+            }
+            
+            // Equal values share one copy
+            std::unordered_map<std::string_view, std::uint64_t> value_offsets;
+            layout.value_offsets.resize(records.size());
+            for(std::size_t slot = 0; slot < layout.slots.size(); ++slot) {
+                const DictValue& value = layout.slots[slot]->second;
+                const auto inserted = value_offsets.insert({ std::string_view(value.c_str(), value.size()), offset });
+                if(inserted.second) {
+                    offset += value.size() + 1;
+                }
+                layout.value_offsets[slot] = inserted.first->second;
+            }
+            
+            layout.total_size = align_image_size(offset);
+            return true;
+        }
+        
+        /*
+         * Writes the planned image into the memory block.
+         * The block must have at least layout.total_size bytes
+         * and be aligned as DictImageHeader.
+         *
+         * The image is marked as ready at the very end
+         * (with release semantics), so readers that see the flag
+         * see the whole image.
+         *
+         * @param[in] layout : planned image
+         * @param[in] base   : destination block
+         */
+        void write_image(const DictImageLayout& layout, char* base) {
+            std::memset(base, 0, layout.total_size);
+            
+            DictImageHeader* header = new (base) DictImageHeader;
+            header->magic = DICT_IMAGE_MAGIC;
+            header->version = DICT_IMAGE_VERSION;
+            header->hash_function = KeyHasher::ID;
+            header->hash_seed = layout.hash_seed;
+            header->ready.store(0, std::memory_order_relaxed);
+            header->total_size = layout.total_size;
+            header->entries_count = layout.slots.size();
+            header->displacement_count = layout.displacements.size();
+            header->displacements_offset = align_image_size(sizeof(DictImageHeader));
+            header->entries_offset = header->displacements_offset
+                + align_image_size(layout.displacements.size() * sizeof(std::uint32_t));
+            
+            std::memcpy(base + header->displacements_offset, layout.displacements.data(),
+                layout.displacements.size() * sizeof(std::uint32_t));
+            
+            DictImageEntry* entries = reinterpret_cast<DictImageEntry*>(base + header->entries_offset);
+            std::uint64_t key_offset = layout.keys_offset;
+            
+            for(std::size_t slot = 0; slot < layout.slots.size(); ++slot) {
+                const HashedKey& key = layout.slots[slot]->first;
+                const DictValue& value = layout.slots[slot]->second;
+                
+                DictImageEntry& entry = entries[slot];
+                entry.hash = layout.hashes[slot];
+                entry.key_offset = key_offset;
+                entry.value_offset = layout.value_offsets[slot];
+                entry.key_length = static_cast<std::uint32_t>(key.text.size());
+                entry.value_length = static_cast<std::uint32_t>(value.size());
+                
+                std::memcpy(base + entry.key_offset, key.text.c_str(), key.text.size() + 1);
+                std::memcpy(base + entry.value_offset, value.c_str(), value.size() + 1);
+                
+                key_offset += key.text.size() + 1;
+            }
+            
+            header->ready.store(1, std::memory_order_release);
+        }
+        
+        /*
+         * Builds the image of dictionary in memory of this process.
+         *
+         * @param[in]  dict  : source dictionary
+         * @param[out] image : built image
+         * @returns If the image was built?
+         */
+        bool build_image(const Dict& dict, DictImage& image) {
+            DictImageLayout layout;
+            if(!plan_image(dict, layout)) return false;
+            
+            // Words keep the block aligned as DictImageHeader
+            std::uint64_t* block = new std::uint64_t[layout.total_size / sizeof(std::uint64_t)];
+            write_image(layout, reinterpret_cast<char*>(block));
+            
+            image.storage = std::shared_ptr<const char>(reinterpret_cast<const char*>(block),
+                [block](const char*) {
+                    delete[] block;
+                });
+            return true;
+        }
+        
+        /*
+         * Copies the image into the memory block.
+         * The block must have at least total_size bytes of the image,
+         * be aligned as DictImageHeader and be filled with zeros.
+         *
+         * Like in write_image the image is marked as ready at the very end.
+         *
+         * @param[in] image : source image
+         * @param[in] base  : destination block
+         */
+        void copy_image(const DictImage& image, char* base) {
+            const char* source = image.storage.get();
+            const std::size_t ready_begin = offsetof(DictImageHeader, ready);
+            const std::size_t ready_end = ready_begin + sizeof(DictImageHeader::ready);
+            
+            std::memcpy(base, source, ready_begin);
+            std::memcpy(base + ready_end, source + ready_end, image.header()->total_size - ready_end);
+            
+            reinterpret_cast<DictImageHeader*>(base)->ready.store(1, std::memory_order_release);
+        }
+        
+        /*
+         * Checks if count items of given size starting at offset
+         * fit in the image of total_size bytes.
+         * Written so that nothing overflows.
+         *
+         * @param[in] offset     : offset of the first item
+         * @param[in] count      : number of items
+         * @param[in] item_size  : size of one item
+         * @param[in] total_size : size of the image
+         * @returns If the range is inside the image?
+         */
+        bool is_image_range(const std::uint64_t offset, const std::uint64_t count,
+            const std::uint64_t item_size, const std::uint64_t total_size) {
+            if(offset > total_size) return false;
+            return count <= (total_size - offset) / item_size;
+        }
+        
+        /*
+         * Checks if the memory block contains complete dictionary image.
+         *
+         * All offsets stored in the image are checked once,
+         * so lookups never read outside the block,
+         * even if the segment is truncated or corrupted.
+         *
+         * @param[in] base : memory block
+         * @param[in] size : size of the block
+         * @returns If the image is valid?
+         */
+        bool is_valid_image(const char* base, const std::size_t size) {
+            if(size < sizeof(DictImageHeader)) return false;
+            
+            const DictImageHeader* header = reinterpret_cast<const DictImageHeader*>(base);
+            if(header->magic != DICT_IMAGE_MAGIC) return false;
+            if(header->version != DICT_IMAGE_VERSION) return false;
+            if(header->hash_function != KeyHasher::ID) return false;
+            if(header->ready.load(std::memory_order_acquire) != 1) return false;
+            
+            const std::uint64_t total_size = header->total_size;
+            if(total_size > size || total_size < sizeof(DictImageHeader)) return false;
+            if(header->displacement_count == 0) return false;
+            
+            // Displacements follow the header, entries follow displacements
+            if(header->displacements_offset < sizeof(DictImageHeader)) return false;
+            if(header->displacements_offset % alignof(std::uint32_t) != 0) return false;
+            if(!is_image_range(header->displacements_offset, header->displacement_count,
+                sizeof(std::uint32_t), total_size)) return false;
+            if(header->entries_offset < header->displacements_offset
+                + header->displacement_count * sizeof(std::uint32_t)) return false;
+            if(header->entries_offset % alignof(DictImageEntry) != 0) return false;
+            if(!is_image_range(header->entries_offset, header->entries_count,
+                sizeof(DictImageEntry), total_size)) return false;
+            
+            // Keys and values must be null-terminated strings inside the image
+            const DictImageEntry* entries = reinterpret_cast<const DictImageEntry*>(base + header->entries_offset);
+            for(std::uint64_t slot = 0; slot < header->entries_count; ++slot) {
+                const DictImageEntry& entry = entries[slot];
+                if(!is_image_range(entry.key_offset, entry.key_length + 1ULL, 1, total_size)) return false;
+                if(!is_image_range(entry.value_offset, entry.value_length + 1ULL, 1, total_size)) return false;
+                if(base[entry.key_offset + entry.key_length] != '\0') return false;
+                if(base[entry.value_offset + entry.value_length] != '\0') return false;
+            }
+            
+            return true;
+        }
+        
+        /*
+         * Searches the dictionary image for the key.
+         * Only one entry is compared with the key, reading
+         * the displacement, the entry, the key and the value.
+         * The image is never modified, so no locking is needed.
+         *
+         * @param[in] image : dictionary image
+         * @param[in] key   : searched key
+         * @returns pointer to the value or nullptr
+         */
+        const char* find_in_image(const DictImage& image, const HashedKey& key) {
+            const DictImageHeader* header = image.header();
+            if(header->entries_count == 0) return nullptr;
+            
+            const std::uint64_t hash = hash_image_key(header, key);
+            const std::uint32_t displacement = image.displacements()[
+                get_image_displacement_index(hash, header->displacement_count)];
+            const DictImageEntry& entry = image.entries()[
+                get_image_slot(hash, displacement, header->entries_count)];
+            
+            if(entry.hash != hash || entry.key_length != key.text.size()) return nullptr;
+            if(std::memcmp(image.text(entry.key_offset), key.text.data(), key.text.size()) != 0) return nullptr;
+            
+            return image.text(entry.value_offset);
+        }
+        
+        /*
+         * Converts the dictionary image back to the mutable dictionary.
+         *
+         * @param[in] image : dictionary image
+         * @returns Dict with all records of the image
+         */
+        Dict read_image(const DictImage& image) {
+            Dict dict;
+            dict.reserve(image.header()->entries_count);
+            
+            const DictImageEntry* entries = image.entries();
+            for(std::uint64_t slot = 0; slot < image.header()->entries_count; ++slot) {
+                const DictImageEntry& entry = entries[slot];
+                std::string key(image.text(entry.key_offset), entry.key_length);
+                std::string value(image.text(entry.value_offset), entry.value_length);
+                
+                dict.insert({ HashedKey(std::move(key)), std::move(value) });
+            }
+            
+            // Each record is stored in exactly one entry
+            assert(dict.size() == image.header()->entries_count);
+            return dict;
+        }
+        
+        /*
+         * Returns count of records in the dictionary.
+         *
+         * @param[in] record : dictionary
+         * @returns size_t count of records
+         */
+        std::size_t get_record_size(const DictRecord& record) {
+            if(record.is_image()) {
+                return record.image.header()->entries_count;
+            }
+            return record.entries.size();
+        }
+        
+        /*
+         * Searches the dictionary for the key.
+         *
+         * @param[in] record : dictionary
+         * @param[in] key    : searched key
+         * @returns pointer to the value or nullptr
+         */
+        const char* find_in_record(const DictRecord& record, const HashedKey& key) {
+            if(record.is_image()) {
+                return find_in_image(record.image, key);
+            }
+            
+            const DictConstIterator i = record.entries.find(key);
+            if(i == record.entries.end()) {
+                return nullptr;
+            }
+            return (i->second).c_str();
+        }
+        
+        /*
+         * Searches the dictionary with given id and then
+         * the global dictionary for the key.
+         * The caller must hold DictReadLock.
+         *
+         * @param[in] id  : dictionary id
+         * @param[in] key : searched key
+         * @returns pointer to the value or nullptr
+         */
+        const char* find_value(const unsigned long& id, const HashedKey& key) {
+            const char* value = nullptr;
+            if(is_valid_id(id)) {
+                value = find_in_record(get_record(id), key);
+            }
+            if(value == nullptr) {
+                // Global dictionary lookup
+                value = find_in_record(get_record(0), key);
+            }
+            return value;
+        }
+        
+        /*
+         * Prepares the dictionary with given id for modification.
+         * Frozen dictionaries are thawed.
+         * Logs attempts to modify shared dictionaries.
+         *
+         * @param[in] function_name : name of the modifying function
+         * @param[in] id            : dictionary id
+         * @returns If the dictionary exists and can be modified?
+         */
+        bool prepare_mutable_id(const char* function_name, const unsigned long& id) {
+            if(!is_valid_id(id)) return false;
+            
+            DictRecord& record = get_dict_container()[id];
+            if(record.is_shared) {
+                log_formated(std::cerr, function_name,
+                    "%{function_name}: %{dict} is read-only\n", id);
+                return false;
+            }
+            if(record.is_image()) {
+                log_formated(std::cerr, function_name,
+                    "%{function_name}: %{dict} is thawed\n", id);
+                record.entries = read_image(record.image);
+                record.image.storage.reset();
+            }
+            return true;
         }
+
+        /*
+         * Creates new empty dictionary and returns its id.
+         * The caller must hold DictWriteLock.
+         *
+         * If USE_ID_COMPACT_ALLOC_MODE is ON then ids are reused
+         * (after dictionary removal)
+         * If not then id assigned once (and even deleted) is never
+         * used again.
+         *
+         * @returns id of newly created dictionary
+         */
+        unsigned long new_dict_id() {
+            // Find first free id in the container
+            static unsigned long global_id_counter = 1;
+            unsigned long free_id = 0;
+            
+            if(USE_ID_COMPACT_ALLOC_MODE) {
+                unsigned long last_id = 0;
+                bool free_id_found = false;
+                
+                for ( const auto &dict : get_dict_container() ) {
+                    if(dict.first != 0 && dict.first != last_id+1) {
+                        free_id = last_id+1;
+                        free_id_found = true;
+                        break;
+                    }
+                    last_id = dict.first;
+                }
+                
+                if(!free_id_found) {
+                    free_id = last_id+1;
+                }
+            } else {
+                free_id = global_id_counter;
+                ++global_id_counter;
+            }
+            
+            // There's no value with free_id key
+            assert(get_dict_container().find(free_id) == get_dict_container().end());
+            // We do not return global dictionary key
+            assert(free_id != 0);
+            
+            // Create new dictionary
+            get_dict_container().insert( { free_id, DictRecord() } );
+            
+            // Key free_id is now present
+            assert(get_dict_container().find(free_id) != get_dict_container().end());
+            
+            return free_id;
+        }
+      
+    } //anonymous namespace
+       
+     
+    // Create new dict and return its id
+    unsigned long dict_new() {
         
-        // There's no value with free_id key
-        assert(get_dict_container().find(free_id) == get_dict_container().end());
-        // We do not return global dictionary key
-        assert(free_id != 0);
+        log("%{function_name}()\n");
         
-        // Create new dictionary
-        get_dict_container().insert( { free_id, Dict() } );
+        DictWriteLock lock;
         
-        // Key free_id is now present
-        assert(get_dict_container().find(free_id) != get_dict_container().end());    
+        const unsigned long free_id = new_dict_id();
         
         log("%{function_name}: dict %{dict}\n", free_id);
         
@@ -280,6 +1327,8 @@ extern "C" {
            log("%{function_name}: an attempt to remove the Global Dictionary\n");
         }
         
+        DictWriteLock lock;
+        
         if(!is_valid_id(id) || id == 0) return;
         get_dict_container().erase(id);
         
@@ -294,9 +1343,11 @@ extern "C" {
         
         log("%{function_name}(%{dict})\n", id);
         
+        DictReadLock lock;
+        
         if(!is_valid_id(id)) return 0;
         
-        const std::size_t size = get_dict_container()[id].size();
+        const std::size_t size = get_record_size(get_record(id));
 
         log("dict %{dict} contains %{size_t} element(s)\n", id);
         
@@ -308,25 +1359,26 @@ extern "C" {
      
         log("%{function_name}(%{dict}, %{cstring}, %{cstring})\n", id, key, value);
         
+        DictWriteLock lock;
       
-        if(!is_valid_id(id)) return;
         if(key == nullptr || value == nullptr) return;
+        if(!prepare_mutable_id(__func__, id)) return;
       
         // If it's global dictionary and it's filled
         // then do nothing
         if(id == 0) {
-            if(dict_size(0) >= MAX_GLOBAL_DICT_SIZE) {
+            if(get_record_size(get_record(0)) >= MAX_GLOBAL_DICT_SIZE) {
                 return;
             }
         }
       
-        const std::string key_str(key);
+        const HashedKey key_hashed(key);
         const std::string value_str(value);
       
-        get_dict_container()[id].insert({ key_str, value_str });
+        get_dict_container()[id].entries.insert({ key_hashed, value_str });
       
         // Global dictionary has maximum size MAX_GLOBAL_DICT_SIZE
-        assert(id != 0 || get_dict_container()[id].size() <= MAX_GLOBAL_DICT_SIZE);    
+        assert(id != 0 || get_dict_container()[id].entries.size() <= MAX_GLOBAL_DICT_SIZE);    
       
         log("%{function_name}: dict %{dict}, "
             "the pair (%{cstring}, %{cstring}) "
@@ -334,23 +1386,112 @@ extern "C" {
         
     }
 
+    // Insert or overwrite record in dict
+    void dict_upsert(unsigned long id, const char* key, const char* value) {
+        
+        log("%{function_name}(%{dict}, %{cstring}, %{cstring})\n", id, key, value);
+        
+        DictWriteLock lock;
+        
+        if(key == nullptr || value == nullptr) return;
+        if(!prepare_mutable_id(__func__, id)) return;
+        
+        const auto inserted = try_insert(id, key, value);
+        if(inserted.first == get_dict_container()[id].entries.end()) {
+            log("%{function_name}: %{dict} is full\n", id);
+            return;
+        }
+        if(!inserted.second) {
+            // Reuses the memory of old value if possible
+            inserted.first->second = value;
+        }
+        
+        log("%{function_name}: dict %{dict}, "
+            "the key %{cstring} has the value %{cstring}\n", id, key, value);
+    }
+    
+    // Get value from dict or insert it
+    const char* dict_find_or_insert(unsigned long id, const char* key, const char* value) {
+        
+        log("%{function_name}(%{dict}, %{cstring}, %{cstring})\n", id, key, value);
+        
+        DictWriteLock lock;
+        
+        if(key == nullptr || value == nullptr) return nullptr;
+        if(!prepare_mutable_id(__func__, id)) return nullptr;
+        
+        const auto inserted = try_insert(id, key, value);
+        if(inserted.first == get_dict_container()[id].entries.end()) {
+            log("%{function_name}: %{dict} is full\n", id);
+            return nullptr;
+        }
+        
+        const char* stored_value = (inserted.first->second).c_str();
+        
+        log("%{function_name}: dict %{dict}, "
+            "the key %{cstring} has the value %{cstring}\n", id, key, stored_value);
+        
+        return stored_value;
+    }
+    
+    // Replace value in dict if it's equal to expected one
+    int dict_compare_and_swap(unsigned long id, const char* key,
+        const char* expected, const char* desired) {
+        
+        log("%{function_name}(%{dict}, %{cstring}, %{cstring}, %{cstring})\n",
+            id, key, expected, desired);
+        
+        DictWriteLock lock;
+        
+        if(key == nullptr || desired == nullptr) return 0;
+        if(!prepare_mutable_id(__func__, id)) return 0;
+        
+        // NULL expected value means that the key is absent
+        if(expected == nullptr) {
+            const auto inserted = try_insert(id, key, desired);
+            log("%{function_name}: %{dict}, swapped: %{int}\n", id, inserted.second ? 1 : 0);
+            return inserted.second ? 1 : 0;
+        }
+        
+        Dict& dict = get_dict_container()[id].entries;
+        const Dict::iterator i = dict.find(HashedKey(key));
+        
+        // Values are replaced in place, so expected value pointing
+        // to the stored one (e.g. returned by dict_find) would always match
+        if(i != dict.end() && expected == (i->second).c_str()) {
+            log("%{function_name}: expected value points into %{dict}\n", id);
+            return 0;
+        }
+        if(i == dict.end() || i->second != expected) {
+            log("%{function_name}: %{dict}, swapped: %{int}\n", id, 0);
+            return 0;
+        }
+        i->second = desired;
+        
+        log("%{function_name}: %{dict}, swapped: %{int}\n", id, 1);
+        
+        return 1;
+    }
+
     // Remove record from dict
     void dict_remove(unsigned long id, const char* key) {
 
         log("%{function_name}(%{dict}, %{cstring})\n", id, key);
+        
+        DictWriteLock lock;
     
-        if(!is_valid_id(id)) return;
         if(key == nullptr) return;
+        if(!prepare_mutable_id(__func__, id)) return;
         
-        if(get_dict_container()[id].find(key) == get_dict_container()[id].end()) {
+        Dict& dict = get_dict_container()[id].entries;
+        const HashedKey key_hashed(key);
+        if(dict.erase(key_hashed) == 0) {
            log("%{function_name}: %{dict} does not "
                "contain the key %{cstring}\n", id, key);
-        } else {
-            get_dict_container()[id].erase(key);
         }
         
         // Dictionary hasn't got that key anymore
-        assert(get_dict_container()[id].find(key) == get_dict_container()[id].end());
+        assert(dict.find(key_hashed) == dict.end());
         
         log("%{function_name}: %{dict}, "
             "the key %{cstring} has been removed\n", id, key);
@@ -362,27 +1503,21 @@ extern "C" {
       
         log("%{function_name}(%{dict}, %{cstring})\n", id, key);
       
-        if(!is_valid_id(id)) return nullptr;
         if(key == nullptr) return nullptr;
         
         // The key could not be NULL
         assert(key != nullptr);
         
-        DictConstIterator i = get_dict_container()[id].find(std::string(key));
-        if(i == get_dict_container()[id].end()) {
-            // Global dictionary lookup
-            i = get_dict_container()[0].find(std::string(key));
-            if(i == get_dict_container()[id].end()) {
-                log("%{function_name}: the key %{cstring} not found\n", key);
-                return nullptr;
-            }
-        }
+        // The key is hashed once for both lookups
+        const HashedKey key_hashed(key);
         
-        // Check if i is valid interator object
-        assert(i != get_dict_container()[id].end());
-        assert(i != get_dict_container()[0].end());
+        DictReadLock lock;
         
-        const char* value = (i->second).c_str();
+        const char* value = find_value(id, key_hashed);
+        if(value == nullptr) {
+            log("%{function_name}: the key %{cstring} not found\n", key);
+            return nullptr;
+        }
         
         log("%{function_name}: dict %{dict}, "
             "the key %{cstring} has the value %{cstring}\n", id, key, value);
@@ -390,17 +1525,60 @@ extern "C" {
         return value;
     }
 
+    // Copy value from dict to the buffer
+    std::size_t dict_find_copy(unsigned long id, const char* key,
+        char* buffer, std::size_t buffer_size) {
+        
+        log("%{function_name}(%{dict}, %{cstring}, %{size_t})\n", id, key, buffer_size);
+        
+        if(key == nullptr) return 0;
+        if(buffer == nullptr && buffer_size != 0) return 0;
+        
+        const HashedKey key_hashed(key);
+        
+        // The value is copied before the lock is released
+        DictReadLock lock;
+        
+        const char* value = find_value(id, key_hashed);
+        if(value == nullptr) {
+            log("%{function_name}: the key %{cstring} not found\n", key);
+            return 0;
+        }
+        
+        const std::size_t value_size = std::strlen(value) + 1;
+        if(buffer_size != 0) {
+            const std::size_t copied_size = std::min(value_size, buffer_size) - 1;
+            std::memcpy(buffer, value, copied_size);
+            buffer[copied_size] = '\0';
+        }
+        
+        log("%{function_name}: dict %{dict}, "
+            "the key %{cstring} has the value %{cstring}\n", id, key, value);
+        
+        return value_size;
+    }
+
     // Erase all records in dict
     void dict_clear(unsigned long id) {
         log("%{function_name}(%{dict})\n", id);
         
+        DictWriteLock lock;
+        
         if(!is_valid_id(id)) return;
-        get_dict_container()[id].clear();
+        
+        // Frozen dictionary is dropped without thawing
+        DictRecord& record = get_dict_container()[id];
+        if(record.is_image() && !record.is_shared) {
+            record.image.storage.reset();
+        }
+        
+        if(!prepare_mutable_id(__func__, id)) return;
+        get_dict_container()[id].entries.clear();
         
         log("%{function_name}: %{dict} has been cleared\n", id);
              
         // The size of dictionary is zero
-        assert(get_dict_container()[id].size() == 0); 
+        assert(get_dict_container()[id].entries.size() == 0); 
     }
 
     // Copy dicts src -> dst
@@ -413,19 +1591,39 @@ extern "C" {
         // is the same
         if(src_id == dst_id) return;
         
+        DictWriteLock lock;
+        
         if(!is_valid_id(src_id)) return;
         if(!is_valid_id(dst_id)) return;
         
         unsigned long copied_entries_count = 0;
+        const DictRecord& src_record = get_dict_container()[src_id];
+        
+        // Images are immutable, so the copy of
+        // frozen or shared dictionary shares the image
+        // and becomes a frozen dictionary
+        if(dst_id != 0 && src_record.is_image() && !get_dict_container()[dst_id].is_shared) {
+            DictRecord& dst_record = get_dict_container()[dst_id];
+            dst_record.entries.clear();
+            dst_record.image = src_record.image;
+            
+            log("%{function_name}: %{dict} shares the image of %{dict}\n", dst_id, src_id);
+            return;
+        }
+        
+        if(!prepare_mutable_id(__func__, dst_id)) return;
+        
+        // Other read-only dictionaries are copied record by record
+        const Dict src_image_entries = src_record.is_image() ? read_image(src_record.image) : Dict();
+        const Dict& src_ref = src_record.is_image() ? src_image_entries : src_record.entries;
         
         // Copy to global dict
         if(dst_id == 0) {
             // Prevent overflows
             // Clear global dict
-            get_dict_container()[0].clear();
+            get_dict_container()[0].entries.clear();
             
-            const auto& src_ref = get_dict_container()[src_id];
-            std::size_t global_dict_size = get_dict_container()[0].size();
+            std::size_t global_dict_size = get_dict_container()[0].entries.size();
             for(auto& record : src_ref) {
                 if(global_dict_size >= MAX_GLOBAL_DICT_SIZE) {
                     // Prevent global dict overflow
@@ -433,23 +1631,166 @@ extern "C" {
                 }
                 
                 // Copy record
-                get_dict_container()[0][record.first] = record.second;
+                get_dict_container()[0].entries.insert_or_assign(record.first, record.second);
                 ++global_dict_size;
                 ++copied_entries_count;
             }
             
             // Never allow to overflow
-            assert(get_dict_container()[0].size() <= MAX_GLOBAL_DICT_SIZE);
+            assert(get_dict_container()[0].entries.size() <= MAX_GLOBAL_DICT_SIZE);
         } else {
-            get_dict_container()[dst_id] = get_dict_container()[src_id];
-            copied_entries_count = get_dict_container()[dst_id].size();
+            get_dict_container()[dst_id].entries = src_ref;
+            copied_entries_count = get_dict_container()[dst_id].entries.size();
             
             // The size of both dictionaries is the same
-            assert(get_dict_container()[dst_id].size() == get_dict_container()[src_id].size());
+            assert(get_dict_container()[dst_id].entries.size() == get_record_size(src_record));
         }
         
         log("%{function_name}: %{ulong} entries were copied\n", copied_entries_count);
         
     }
 
+    // Convert dict to read-only image
+    void dict_freeze(unsigned long id) {
+        
+        log("%{function_name}(%{dict})\n", id);
+        
+        DictWriteLock lock;
+        
+        if(!is_valid_id(id)) return;
+        
+        DictRecord& record = get_dict_container()[id];
+        if(record.is_image()) {
+            log("%{function_name}: %{dict} is already read-only\n", id);
+            return;
+        }
+        
+        DictImage image;
+        if(!build_image(record.entries, image)) {
+            log("%{function_name}: cannot build the image of %{dict}\n", id);
+            return;
+        }
+        
+        record.image = image;
+        Dict().swap(record.entries);
+        
+        log("%{function_name}: %{dict} has been frozen\n", id);
+    }
+
+    // Publish dict in shared memory segment
+    int dict_share(unsigned long id, const char* name) {
+        
+        log("%{function_name}(%{dict}, %{cstring})\n", id, name);
+        
+        DictReadLock lock;
+        
+        if(!is_valid_id(id)) return 0;
+        if(name == nullptr) return 0;
+        
+        // Images are position independent, so frozen
+        // and shared dictionaries are copied as they are
+        const DictRecord& record = get_record(id);
+        DictImageLayout layout;
+        if(!record.is_image() && !plan_image(record.entries, layout)) {
+            log("%{function_name}: cannot build the image of %{dict}\n", id);
+            return 0;
+        }
+        const std::size_t size = record.is_image() ? record.image.header()->total_size : layout.total_size;
+        
+        // Readers that already mapped the old segment keep it
+        shm_unlink(name);
+        
+        const int fd = shm_open(name, O_CREAT | O_EXCL | O_RDWR, 0644);
+        if(fd < 0) {
+            log("%{function_name}: cannot create segment %{cstring}\n", name);
+            return 0;
+        }
+        
+        if(ftruncate(fd, static_cast<off_t>(size)) != 0) {
+            log("%{function_name}: cannot resize segment %{cstring}\n", name);
+            close(fd);
+            shm_unlink(name);
+            return 0;
+        }
+        
+        void* base = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        close(fd);
+        if(base == MAP_FAILED) {
+            log("%{function_name}: cannot map segment %{cstring}\n", name);
+            shm_unlink(name);
+            return 0;
+        }
+        
+        if(record.is_image()) {
+            copy_image(record.image, static_cast<char*>(base));
+        } else {
+            write_image(layout, static_cast<char*>(base));
+        }
+        munmap(base, size);
+        
+        log("%{function_name}: %{dict} has been published as %{cstring}\n", id, name);
+        
+        return 1;
+    }
+    
+    // Map shared memory segment as read-only dict
+    unsigned long dict_attach(const char* name) {
+        
+        log("%{function_name}(%{cstring})\n", name);
+        
+        if(name == nullptr) return 0;
+        
+        const int fd = shm_open(name, O_RDONLY, 0);
+        if(fd < 0) {
+            log("%{function_name}: segment %{cstring} does not exist\n", name);
+            return 0;
+        }
+        
+        struct stat segment_stat;
+        if(fstat(fd, &segment_stat) != 0 || segment_stat.st_size <= 0) {
+            close(fd);
+            log("%{function_name}: segment %{cstring} is empty\n", name);
+            return 0;
+        }
+        
+        const std::size_t size = static_cast<std::size_t>(segment_stat.st_size);
+        void* base = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+        close(fd);
+        if(base == MAP_FAILED) {
+            log("%{function_name}: cannot map segment %{cstring}\n", name);
+            return 0;
+        }
+        
+        DictImage image;
+        image.storage = std::shared_ptr<const char>(static_cast<const char*>(base),
+            [size](const char* mapping) {
+                munmap(const_cast<char*>(mapping), size);
+            });
+        
+        if(!is_valid_image(image.storage.get(), size)) {
+            log("%{function_name}: segment %{cstring} is not a dictionary\n", name);
+            return 0;
+        }
+        
+        // The dictionary is registered already read-only
+        DictWriteLock lock;
+        const unsigned long id = new_dict_id();
+        DictRecord& record = get_dict_container().find(id)->second;
+        record.image = image;
+        record.is_shared = true;
+        
+        log("%{function_name}: %{cstring} has been attached as %{dict}\n", name, id);
+        
+        return id;
+    }
+    
+    // Remove shared memory segment name
+    void dict_unshare(const char* name) {
+        
+        log("%{function_name}(%{cstring})\n", name);
+        
+        if(name == nullptr) return;
+        shm_unlink(name);
+    }
+
 } // extern C
\ No newline at end of file
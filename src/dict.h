@@ -57,6 +57,76 @@ size_t dict_size(unsigned long id);
  */
 void dict_insert(unsigned long id, const char* key, const char* value);
 
+/*
+ * Puts a record in the dictionary with a given id,
+ * overwriting the value if the key already exists.
+ * The key is looked up only once.
+ *
+ * If the given key or value is NULL then
+ * the function call has no effects.
+ *
+ * If no dictionary with such id exists then
+ * the function call has no effects.
+ *
+ * @param[in] id    : id of dictionary
+ * @param[in] key   : key of entry
+ * @param[in] value : new value of entry
+ */
+void dict_upsert(unsigned long id, const char* key, const char* value);
+
+/*
+ * Returns the value saved under the specified key
+ * in the dictionary with a given id.
+ * If there's no such key, puts the given value under it
+ * and returns the stored copy.
+ * The key is looked up only once.
+ *
+ * Unlike dict_find the global dictionary is not searched.
+ *
+ * If the given key or value is NULL or no dictionary
+ * with such id exists then NULL is returned.
+ * NULL is also returned if the dictionary is the global one,
+ * it's full and has no such key.
+ *
+ * Like for dict_find the pointer is valid until the record
+ * is modified, so with DICT_THREAD_SAFE read it with dict_find_copy.
+ *
+ * @param[in] id    : id of dictionary
+ * @param[in] key   : key of entry
+ * @param[in] value : value inserted if the key is absent
+ * @returns pointer to the value saved under the given key
+ */
+const char* dict_find_or_insert(unsigned long id, const char* key, const char* value);
+
+/*
+ * Replaces the value saved under the specified key
+ * in the dictionary with a given id with desired one,
+ * only if it's equal to expected one.
+ * If expected is NULL the record is put only if
+ * there's no such key in the dictionary
+ * (and the global dictionary is not full).
+ * The key is looked up only once.
+ *
+ * The expected value must be owned by the caller
+ * (e.g. read with dict_find_copy). Values are replaced in place,
+ * so a pointer returned by dict_find would always be equal
+ * to the current value. Such calls fail.
+ *
+ * If the given key or desired value is NULL or no dictionary
+ * with such id exists then the function call has no effects.
+ *
+ * When built with DICT_THREAD_SAFE (like all the functions)
+ * the operation is atomic.
+ *
+ * @param[in] id       : id of dictionary
+ * @param[in] key      : key of entry
+ * @param[in] expected : expected current value or NULL
+ * @param[in] desired  : new value of entry
+ * @returns 1 if the value was replaced, 0 otherwise
+ */
+int dict_compare_and_swap(unsigned long id, const char* key,
+    const char* expected, const char* desired);
+
 /*
  * Removes record from the dictionary
  * specified by id.
@@ -85,12 +155,37 @@ void dict_remove(unsigned long id, const char* key);
  * If there's no such key in global dictionary
  * then NULL is returned.
  *
+ * The pointer is valid until the record is modified.
+ * If the dictionary holding the record is frozen, the pointer
+ * is valid only until that dictionary is modified (see dict_freeze).
+ * This includes pointers into the frozen global dictionary.
+ * When built with DICT_THREAD_SAFE other threads may modify it
+ * at any time, so use dict_find_copy instead.
+ *
  * @param[in] id    : id of dictionary
  * @param[in] key   : key of entry that will be removed
  * @returns pointer to the value saved under the given key
  */
 const char* dict_find(unsigned long id, const char* key);
 
+/*
+ * Works like dict_find, but copies the value
+ * into the buffer provided by the caller
+ * (before other threads can modify it).
+ *
+ * At most buffer_size - 1 characters are copied
+ * and the copy is always null-terminated.
+ * If buffer_size is zero nothing is copied.
+ *
+ * @param[in]  id          : id of dictionary
+ * @param[in]  key         : key of entry
+ * @param[out] buffer      : buffer for the value
+ * @param[in]  buffer_size : size of the buffer
+ * @returns size of the whole value (with terminating null)
+ *          or 0 if no value is found
+ */
+size_t dict_find_copy(unsigned long id, const char* key, char* buffer, size_t buffer_size);
+
 /*
  * Clears the dictionary
  * with a given id.
@@ -115,5 +210,76 @@ void dict_clear(unsigned long id);
  * @param[in] dst_id : id of the destination dictionary
  */
 void dict_copy(unsigned long src_id, unsigned long dst_id);
+
+/*
+ * Freezes the dictionary with given id.
+ *
+ * The records are moved into a compact read-only image:
+ * a single block indexed by minimal perfect hash,
+ * where equal values are stored only once.
+ * dict_find on frozen dictionary compares the key with only one record.
+ * It reads the displacement table (about a byte per record),
+ * the record, its key and its value (stored apart, as equal values
+ * are shared), so a lookup costs up to four memory reads
+ * rather than a single cache miss.
+ *
+ * Any call that modifies the dictionary (dict_insert, dict_upsert,
+ * dict_find_or_insert, dict_compare_and_swap, dict_remove, dict_clear,
+ * dict_copy into it) thaws it first: it is converted back to
+ * the mutable one and the image is freed.
+ * This invalidates every pointer previously returned by dict_find
+ * for a record of this dictionary, including pointers returned
+ * for other dictionaries that fell back to the frozen global one.
+ * Calls that return early because of NULL key or value do not thaw it.
+ * dict_copy from frozen dictionary shares its image.
+ *
+ * If no dictionary with such id exists or it is
+ * already frozen or attached then the function call has no effects.
+ *
+ * @param[in] id : id of dictionary
+ */
+void dict_freeze(unsigned long id);
+
+/*
+ * Publishes the contents of the dictionary with given id
+ * into the POSIX shared-memory segment with a given name.
+ *
+ * The segment holds a read-only, position-independent
+ * image of the dictionary (all references are offsets),
+ * so other processes can map it at any address with dict_attach.
+ * A segment already published under that name is replaced;
+ * processes that attached the old one keep reading it.
+ *
+ * The segment outlives the process until dict_unshare is called.
+ *
+ * @param[in] id   : id of dictionary
+ * @param[in] name : segment name in shm_open format (e.g. "/words")
+ * @returns 1 if the dictionary was published, 0 otherwise
+ */
+int dict_share(unsigned long id, const char* name);
+
+/*
+ * Maps the shared-memory segment published by dict_share
+ * and returns the id of a new read-only dictionary backed by it.
+ *
+ * Lookups through dict_find take no locks shared between processes.
+ * When built with DICT_THREAD_SAFE they still take
+ * the shared lock of the process, like for other dictionaries.
+ * dict_insert, dict_remove and dict_clear on such dictionary
+ * have no effects, dict_delete unmaps the segment.
+ *
+ * @param[in] name : segment name passed to dict_share
+ * @returns id of attached dictionary or 0 if the segment
+ *          does not exist or is not a valid dictionary image
+ */
+unsigned long dict_attach(const char* name);
+
+/*
+ * Removes the name of shared-memory segment published by dict_share.
+ * Processes that already attached it can still use it.
+ *
+ * @param[in] name : segment name passed to dict_share
+ */
+void dict_unshare(const char* name);
  
 #endif // __DICT__
\ No newline at end of file